@@ -83,6 +83,26 @@ const uint8_t kTimeout = 50; // Milli-Seconds
 // in Hz. e.g. 38kHz.
 const uint16_t kFrequency = 38000;
 
+// kMinUnknownSize is the smallest number of mark/space pulses an UNKNOWN
+// message must have to be accepted. Shorter captures are treated as noise,
+// e.g. short bursts of stray IR.
+const uint16_t kMinUnknownSize = 12;
+
+// kTolerancePercentage is how much (in %) the received timings may differ
+// from the protocol timings and still be decoded. kTolerance is the library
+// default (25%). Raise it for remotes with sloppy timing.
+const uint8_t kTolerancePercentage = kTolerance;
+
+// kPollInterval is how often the receiver is checked for a finished message
+// while recording. Keep it short so a captured message is noticed right away.
+const uint16_t kPollInterval = 10; // Milli-Seconds
+
+// kPrintInterval is how often "waiting for signal..." is printed while recording.
+const uint16_t kPrintInterval = 500; // Milli-Seconds
+
+// kRecordTime is how long we wait for a message after button 1 is pressed.
+const uint16_t kRecordTime = 10000; // Milli-Seconds
+
 // Default Button states
 int button1_state = HIGH;
 int button2_state = HIGH;
@@ -96,6 +116,9 @@ int button2_prev = HIGH;
 // Blinks led on pin, multiplier -times with blink_delay -time(ms) between blinks.
 void blinkled(int pin, int delay, int multiplier);
 
+// Sends the captured message using the matching protocol. Returns false if transmit fails.
+bool sendsignal(decode_results *captured);
+
 // Configure objects
 
 // The IR transmitter.
@@ -104,6 +127,8 @@ IRsend irsend(kIrLedPin);
 IRrecv irrecv(kRecvPin, kCaptureBufferSize, kTimeout, false);
 // Object to store the captured message.
 decode_results results;
+// True when results holds a decoded message ready to be sent.
+bool has_signal = false;
 
 // Setup
 
@@ -123,15 +148,21 @@ void setup()
     digitalWrite(led_pin, LOW);
 
     // Starting serial monitor.
+    // Log texts are wrapped in F() / PSTR() so they stay in flash instead of RAM.
     Serial.begin(kBaudRate, SERIAL_8N1);
     while (!Serial) // Wait for serial port to connect.
         delay(50);
     Serial.println();
-    Serial.print("Serial connection ON");
+    Serial.print(F("Serial connection ON"));
     Serial.println();
 
     // Start up the IR sender.
     irsend.begin();
+
+    // Ignore UNKNOWN messages that are too short to be real signals.
+    irrecv.setUnknownThreshold(kMinUnknownSize);
+    // Timing tolerance used when decoding.
+    irrecv.setTolerance(kTolerancePercentage);
 }
 
 // Main loop
@@ -147,35 +178,66 @@ void loop()
     {
 
         // Start up the IR receiver.
+        // This also wipes the previously recorded signal.
         irrecv.enableIRIn();
+        has_signal = false;
+        // True if the capture buffer overflowed while recording.
+        bool overflow = false;
 
-        Serial.println("Recording IR-signal");
+        Serial.println(F("Recording IR-signal"));
 
         // Blink led once and then leave it on
         // to indicate device is starting recording.
         blinkled(led_pin, 500, 1);
         digitalWrite(led_pin, HIGH);
 
-        // Print out text in serial monitor while waiting for IR-signal.
+        // Print out text in serial monitor every kPrintInterval ms while waiting for IR-signal.
         // If there is no signal after ~10 seconds the loop ends.
         // When signal is received statement turns true and we exit the loop.
-        // delay is there to not flood the serial monitor and to not hit the WDT reset.
-        for (int i = 0; (i < 20); i++)
+        // The receiver is checked every kPollInterval ms so the signal is picked up
+        // as soon as it ends. delay is there to not hit the WDT reset.
+        uint32_t next_print = 0;
+        for (int i = 0; (i < kRecordTime / kPollInterval); i++)
         {
-            Serial.println("waiting for signal...");
-            delay(500);
+            // Time spent waiting so far. Works for any kPollInterval / kPrintInterval pair.
+            if ((uint32_t)i * kPollInterval >= next_print)
+            {
+                Serial.println(F("waiting for signal..."));
+                next_print += kPrintInterval;
+            }
+            delay(kPollInterval);
             if (irrecv.decode(&results))
             {
+                // A repeat code (sent while a remote button is held) can't be
+                // replayed on its own. Skip it and wait for the full message.
+                if (results.repeat)
+                {
+                    irrecv.resume();
+                    continue;
+                }
+                // The message didn't fit in the capture buffer, so it is incomplete.
+                // The remote may still be sending, so restarting the receiver now would
+                // only capture the rest of the same signal. End the recording instead.
+                if (results.overflow)
+                {
+                    overflow = true;
+                    break;
+                }
+                has_signal = true;
                 break;
             }
         }
 
+        // Stop listening. The receiver interrupt and timer are only needed while recording.
+        // The captured message stays in the buffer until the next recording.
+        irrecv.disableIRIn();
+
         // If there is results print out the decoded result.
         // And blink led fast 5 times.
-        if (irrecv.decode(&results))
+        if (has_signal)
         {
             // Received a signal. Blink led 5 times fast.
-            Serial.println("Got results!");
+            Serial.println(F("Got results!"));
             Serial.print(resultToHumanReadableBasic(&results));
             blinkled(led_pin, 50, 5);
         }
@@ -183,7 +245,10 @@ void loop()
         // No signal. Turn off the LED.
         else
         {
-            Serial.println("You took too long! Nothing recorded.");
+            if (overflow)
+                Serial.println(F("Signal too long or garbled. Nothing recorded. Try again."));
+            else
+                Serial.println(F("You took too long! Nothing recorded."));
             digitalWrite(led_pin, LOW);
         }
     }
@@ -192,59 +257,26 @@ void loop()
     if ((button2_prev == LOW) && (button2_state == HIGH))
     {
 
-        if (irrecv.decode(&results))
+        // Use the message decoded when recording. No need to decode it again.
+        if (has_signal)
         {
-            // Check that we have results.
-            // Blink LED 3 times quickly to indicate sending the signal.
-            blinkled(led_pin, 30, 3);
-
-            decode_type_t protocol = results.decode_type;
-            uint16_t size = results.bits;
-            bool success = true;
-
-            // Is it a protocol we don't understand?
-            // Yes.
-            if (protocol == decode_type_t::UNKNOWN)
-            {
-
-                // Convert the results into an array suitable for sendRaw().
-                // resultToRawArray() allocates the memory we need for the array.
-                uint16_t *raw_array = resultToRawArray(&results);
-
-                // Find out how many elements are in the array.
-                size = getCorrectedRawLength(&results);
-
-                // Send it out via the IR LED circuit.
-                irsend.sendRaw(raw_array, size, kFrequency);
-
-                // Deallocate the memory allocated by resultToRawArray().
-                delete[] raw_array;
-            }
-
-            // Does the message require a state[]?
-            else if (hasACState(protocol))
-            {
-                // It does, so send with bytes instead.
-                success = irsend.send(protocol, results.state, size / 8);
-            }
+            // Send right away so the blocking blinks and serial prints don't delay the signal.
+            bool success = sendsignal(&results);
 
-            // Anything else must be a simple message protocol. ie. <= 64 bits
-            else
-            {
-                success = irsend.send(protocol, results.value, size);
-            }
+            // Blink LED 3 times quickly to indicate the signal was sent.
+            blinkled(led_pin, 30, 3);
 
             // Print sent signal. Print "..unsuccessfully.." if transmit fails.
-            Serial.println("Sending IR-signal");
+            Serial.println(F("Sending IR-signal"));
             Serial.print(resultToHumanReadableBasic(&results));
-            Serial.printf("Message %ssuccessfully retransmitted.\n", success ? "" : "un");
+            Serial.printf_P(PSTR("Message %ssuccessfully retransmitted.\n"), success ? "" : "un");
         }
 
         // Indicate that there is no results to send.
         // Blink led twice.
         else
         {
-            Serial.println("Nothing to send. Capture something first.");
+            Serial.println(F("Nothing to send. Capture something first."));
             blinkled(led_pin, 600, 2);
         }
     }
@@ -270,3 +302,45 @@ void blinkled(int pin, int blink_delay, int multiplier)
     }
     return;
 }
+
+// Sends the captured message using the matching protocol. Returns false if transmit fails.
+bool sendsignal(decode_results *captured)
+{
+    decode_type_t protocol = captured->decode_type;
+    uint16_t size = captured->bits;
+    bool success = true;
+
+    // Is it a protocol we don't understand?
+    // Yes.
+    if (protocol == decode_type_t::UNKNOWN)
+    {
+
+        // Convert the results into an array suitable for sendRaw().
+        // resultToRawArray() allocates the memory we need for the array.
+        uint16_t *raw_array = resultToRawArray(captured);
+
+        // Find out how many elements are in the array.
+        size = getCorrectedRawLength(captured);
+
+        // Send it out via the IR LED circuit.
+        irsend.sendRaw(raw_array, size, kFrequency);
+
+        // Deallocate the memory allocated by resultToRawArray().
+        delete[] raw_array;
+    }
+
+    // Does the message require a state[]?
+    else if (hasACState(protocol))
+    {
+        // It does, so send with bytes instead.
+        success = irsend.send(protocol, captured->state, size / 8);
+    }
+
+    // Anything else must be a simple message protocol. ie. <= 64 bits
+    else
+    {
+        success = irsend.send(protocol, captured->value, size);
+    }
+
+    return success;
+}